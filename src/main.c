@@ -1,9 +1,12 @@
 #include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #include "sha2.h"
 
@@ -17,18 +20,217 @@ static enum {
   kSHA384,
 } mode;
 
+enum { kOutputBufsize = (1 << 16) /* 64 KiB */ };
+
+static struct {
+  char data[kOutputBufsize];
+  size_t length;
+} output;
+
+static bool binary_digest;
+
+// Set when stdout is a terminal, so each result is shown as soon as its file
+// has been hashed rather than once the output buffer fills.
+static bool flush_per_file;
+
+#define HEX_ROW(high)                                                       \
+  high "0" high "1" high "2" high "3" high "4" high "5" high "6" high "7" \
+  high "8" high "9" high "a" high "b" high "c" high "d" high "e" high "f"
+
+// Two lowercase hex digits for every byte value, indexed by 2 * byte.
+static const char kHexTable[] =
+    HEX_ROW("0") HEX_ROW("1") HEX_ROW("2") HEX_ROW("3") HEX_ROW("4")
+    HEX_ROW("5") HEX_ROW("6") HEX_ROW("7") HEX_ROW("8") HEX_ROW("9")
+    HEX_ROW("a") HEX_ROW("b") HEX_ROW("c") HEX_ROW("d") HEX_ROW("e")
+    HEX_ROW("f");
+
+#undef HEX_ROW
+
+static void FlushOutput(void) {
+  if (output.length > 0) {
+    fwrite(output.data, sizeof(char), output.length, stdout);
+    output.length = 0;
+  }
+}
+
+// Returns space for len bytes at the end of the output buffer, flushing it
+// first if necessary. len must not exceed kOutputBufsize.
+static char *ReserveOutput(size_t len) {
+  if (output.length + len > kOutputBufsize) {
+    FlushOutput();
+  }
+  char *reserved = output.data + output.length;
+  output.length += len;
+  return reserved;
+}
+
+static void WriteOutput(const void *data, size_t len) {
+  if (len > kOutputBufsize) {
+    FlushOutput();
+    fwrite(data, sizeof(char), len, stdout);
+    return;
+  }
+  memcpy(ReserveOutput(len), data, len);
+}
+
+static void WriteString(const char *str) { WriteOutput(str, strlen(str)); }
+
+static void EncodeHex(char hex[], const uint8_t data[], size_t len) {
+  for (size_t i = 0; i < len; ++i) {
+    memcpy(hex + 2 * i, kHexTable + 2 * (size_t)data[i], 2);
+  }
+}
+
 static void PrintDigest(const char *algorithm, uint8_t digest[],
                         size_t digest_length, const char *filename) {
-  if (algorithm != NULL) {
-    printf("%s: ", algorithm);
+  if (binary_digest) {
+    WriteOutput(digest, digest_length);
+    return;
   }
-  for (size_t i = 0; i < digest_length; ++i) {
-    printf("%02x", digest[i]);
+  if (algorithm != NULL) {
+    WriteString(algorithm);
+    WriteString(": ");
   }
+  EncodeHex(ReserveOutput(2 * digest_length), digest, digest_length);
   if (filename != NULL) {
-    printf("  %s", filename);
+    WriteString("  ");
+    WriteString(filename);
+  }
+  WriteString("\n");
+}
+
+// In kAll mode, the reader fills a ring of buffers and one hasher thread per
+// algorithm family consumes each buffer concurrently. A buffer is reused once
+// every hasher has released it.
+enum { kPipelineDepth = 4 };
+
+enum {
+  kSHA256Hasher,
+  kSHA512Hasher,
+  kHasherCount,
+};
+
+struct PipelineBuffer {
+  uint8_t data[kBufsize];
+  size_t length;
+  int refcount;
+};
+
+static struct Pipeline {
+  struct PipelineBuffer buffers[kPipelineDepth];
+  struct SHA2MultiContext ctx;
+  pthread_mutex_t mutex;
+  pthread_cond_t published_cond;
+  pthread_cond_t released_cond;
+  size_t published;
+  bool stopping;
+  pthread_t hashers[kHasherCount];
+} *pipeline;
+
+static void *HasherMain(void *arg) {
+  int hasher = (int)(intptr_t)arg;
+  size_t consumed = 0;
+  pthread_mutex_lock(&pipeline->mutex);
+  for (;;) {
+    while (consumed == pipeline->published && !pipeline->stopping) {
+      pthread_cond_wait(&pipeline->published_cond, &pipeline->mutex);
+    }
+    if (consumed == pipeline->published) {
+      break;
+    }
+    struct PipelineBuffer *buffer =
+        &pipeline->buffers[consumed % kPipelineDepth];
+    pthread_mutex_unlock(&pipeline->mutex);
+
+    if (hasher == kSHA256Hasher) {
+      SHA256MultiUpdate(&pipeline->ctx.sha256, buffer->data, buffer->length);
+    } else {
+      SHA512MultiUpdate(&pipeline->ctx.sha512, buffer->data, buffer->length);
+    }
+
+    pthread_mutex_lock(&pipeline->mutex);
+    ++consumed;
+    if (--buffer->refcount == 0) {
+      pthread_cond_signal(&pipeline->released_cond);
+    }
+  }
+  pthread_mutex_unlock(&pipeline->mutex);
+  return NULL;
+}
+
+static void StopPipeline(int hasher_count) {
+  pthread_mutex_lock(&pipeline->mutex);
+  pipeline->stopping = true;
+  pthread_cond_broadcast(&pipeline->published_cond);
+  pthread_mutex_unlock(&pipeline->mutex);
+  for (int i = 0; i < hasher_count; ++i) {
+    pthread_join(pipeline->hashers[i], NULL);
   }
-  printf("\n");
+  pthread_cond_destroy(&pipeline->released_cond);
+  pthread_cond_destroy(&pipeline->published_cond);
+  pthread_mutex_destroy(&pipeline->mutex);
+  free(pipeline);
+  pipeline = NULL;
+}
+
+// Leaves pipeline NULL if the hasher threads cannot be started, in which case
+// ProcessFile hashes on the calling thread.
+static void StartPipeline(void) {
+  pipeline = malloc(sizeof(struct Pipeline));
+  if (pipeline == NULL) {
+    return;
+  }
+  for (int i = 0; i < kPipelineDepth; ++i) {
+    pipeline->buffers[i].refcount = 0;
+  }
+  pipeline->published = 0;
+  pipeline->stopping = false;
+  pthread_mutex_init(&pipeline->mutex, NULL);
+  pthread_cond_init(&pipeline->published_cond, NULL);
+  pthread_cond_init(&pipeline->released_cond, NULL);
+  for (int i = 0; i < kHasherCount; ++i) {
+    if (pthread_create(&pipeline->hashers[i], NULL, HasherMain,
+                       (void *)(intptr_t)i) != 0) {
+      StopPipeline(i);
+      return;
+    }
+  }
+}
+
+// Returns the next buffer in the ring once all hashers have released it.
+static uint8_t *AcquireBuffer(void) {
+  struct PipelineBuffer *buffer =
+      &pipeline->buffers[pipeline->published % kPipelineDepth];
+  pthread_mutex_lock(&pipeline->mutex);
+  while (buffer->refcount > 0) {
+    pthread_cond_wait(&pipeline->released_cond, &pipeline->mutex);
+  }
+  pthread_mutex_unlock(&pipeline->mutex);
+  return buffer->data;
+}
+
+// Hands the buffer returned by AcquireBuffer to every hasher.
+static void PublishBuffer(size_t length) {
+  struct PipelineBuffer *buffer =
+      &pipeline->buffers[pipeline->published % kPipelineDepth];
+  pthread_mutex_lock(&pipeline->mutex);
+  buffer->length = length;
+  buffer->refcount = kHasherCount;
+  ++pipeline->published;
+  pthread_cond_broadcast(&pipeline->published_cond);
+  pthread_mutex_unlock(&pipeline->mutex);
+}
+
+// Waits until every published buffer has been hashed, after which
+// pipeline->ctx may be used by the calling thread.
+static void DrainPipeline(void) {
+  pthread_mutex_lock(&pipeline->mutex);
+  for (int i = 0; i < kPipelineDepth; ++i) {
+    while (pipeline->buffers[i].refcount > 0) {
+      pthread_cond_wait(&pipeline->released_cond, &pipeline->mutex);
+    }
+  }
+  pthread_mutex_unlock(&pipeline->mutex);
 }
 
 static void ProcessFile(const char *filename) {
@@ -41,6 +243,7 @@ static void ProcessFile(const char *filename) {
     file = fopen(filename, "rb");
     effective_filename = filename;
     if (file == NULL) {
+      FlushOutput();
       fprintf(stderr, "Error opening %s: %s\n", effective_filename,
               // NOLINTNEXTLINE(concurrency-mt-unsafe)
               strerror(errno));
@@ -48,34 +251,48 @@ static void ProcessFile(const char *filename) {
     }
   }
 
+  struct SHA2MultiContext *multi_ctx = NULL;
   struct SHA256Context *sha256_ctx = NULL;
   struct SHA224Context *sha224_ctx = NULL;
   struct SHA512Context *sha512_ctx = NULL;
   struct SHA384Context *sha384_ctx = NULL;
-  if (mode == kAll || mode == kSHA256) {
+  if (mode == kAll) {
+    multi_ctx = pipeline != NULL ? &pipeline->ctx
+                                 : malloc(sizeof(struct SHA2MultiContext));
+    SHA2MultiInit(multi_ctx);
+  }
+  if (mode == kSHA256) {
     sha256_ctx = malloc(sizeof(struct SHA256Context));
     SHA256Init(sha256_ctx);
   }
-  if (mode == kAll || mode == kSHA224) {
+  if (mode == kSHA224) {
     sha224_ctx = malloc(sizeof(struct SHA224Context));
     SHA224Init(sha224_ctx);
   }
-  if (mode == kAll || mode == kSHA512) {
+  if (mode == kSHA512) {
     sha512_ctx = malloc(sizeof(struct SHA512Context));
     SHA512Init(sha512_ctx);
   }
-  if (mode == kAll || mode == kSHA384) {
+  if (mode == kSHA384) {
     sha384_ctx = malloc(sizeof(struct SHA384Context));
     SHA384Init(sha384_ctx);
   }
 
-  uint8_t buffer[kBufsize];
+  // Only used when no pipeline is running. Static storage keeps it off the
+  // stack, and its pages are never touched while the ring buffers are in use.
+  static uint8_t local_buffer[kBufsize];
+  bool published = false;
   for (;;) {
+    uint8_t *buffer = pipeline != NULL ? AcquireBuffer() : local_buffer;
     size_t len = fread(buffer, sizeof(uint8_t), kBufsize, file);
     if (len == 0) {
+      if (published) {
+        DrainPipeline();
+      }
       if (feof(file)) {
         break;
       }
+      FlushOutput();
       if (ferror(file)) {
         fprintf(stderr, "Error reading from %s: %s\n", effective_filename,
                 // NOLINTNEXTLINE(concurrency-mt-unsafe)
@@ -86,59 +303,88 @@ static void ProcessFile(const char *filename) {
       goto cleanup;
     }
 
-    if (mode == kAll || mode == kSHA256) {
+    if (mode == kAll) {
+      // Buffers go to the hashers only once a full read shows the file may
+      // continue. Smaller files are hashed on this thread, since waking the
+      // hashers would cost more than hashing them.
+      if (pipeline != NULL && (published || len == kBufsize)) {
+        PublishBuffer(len);
+        published = true;
+      } else {
+        SHA2MultiUpdate(multi_ctx, buffer, len);
+      }
+    }
+    if (mode == kSHA256) {
       SHA256Update(sha256_ctx, buffer, len);
     }
-    if (mode == kAll || mode == kSHA224) {
+    if (mode == kSHA224) {
       SHA224Update(sha224_ctx, buffer, len);
     }
-    if (mode == kAll || mode == kSHA512) {
+    if (mode == kSHA512) {
       SHA512Update(sha512_ctx, buffer, len);
     }
-    if (mode == kAll || mode == kSHA384) {
+    if (mode == kSHA384) {
       SHA384Update(sha384_ctx, buffer, len);
     }
   }
 
   if (mode == kAll) {
-    printf("%s:\n", filename);
+    uint8_t sha256_digest[kSHA256DigestLength];
+    uint8_t sha224_digest[kSHA224DigestLength];
+    uint8_t sha512_digest[kSHA512DigestLength];
+    uint8_t sha384_digest[kSHA384DigestLength];
+    SHA2MultiFinal(sha256_digest, sha224_digest, sha512_digest, sha384_digest,
+                   multi_ctx);
+    if (!binary_digest) {
+      WriteString(filename);
+      WriteString(":\n");
+    }
+    PrintDigest("SHA256", sha256_digest, kSHA256DigestLength, NULL);
+    PrintDigest("SHA224", sha224_digest, kSHA224DigestLength, NULL);
+    PrintDigest("SHA512", sha512_digest, kSHA512DigestLength, NULL);
+    PrintDigest("SHA384", sha384_digest, kSHA384DigestLength, NULL);
   }
-  if (mode == kAll || mode == kSHA256) {
+  if (mode == kSHA256) {
     uint8_t sha256_digest[kSHA256DigestLength];
     SHA256Final(sha256_digest, sha256_ctx);
-    PrintDigest(mode == kAll ? "SHA256" : NULL, sha256_digest,
-                kSHA256DigestLength, mode != kAll ? filename : NULL);
+    PrintDigest(NULL, sha256_digest, kSHA256DigestLength, filename);
   }
-  if (mode == kAll || mode == kSHA224) {
+  if (mode == kSHA224) {
     uint8_t sha224_digest[kSHA224DigestLength];
     SHA224Final(sha224_digest, sha224_ctx);
-    PrintDigest(mode == kAll ? "SHA224" : NULL, sha224_digest,
-                kSHA224DigestLength, mode != kAll ? filename : NULL);
+    PrintDigest(NULL, sha224_digest, kSHA224DigestLength, filename);
   }
-  if (mode == kAll || mode == kSHA512) {
+  if (mode == kSHA512) {
     uint8_t sha512_digest[kSHA512DigestLength];
     SHA512Final(sha512_digest, sha512_ctx);
-    PrintDigest(mode == kAll ? "SHA512" : NULL, sha512_digest,
-                kSHA512DigestLength, mode != kAll ? filename : NULL);
+    PrintDigest(NULL, sha512_digest, kSHA512DigestLength, filename);
   }
-  if (mode == kAll || mode == kSHA384) {
+  if (mode == kSHA384) {
     uint8_t sha384_digest[kSHA384DigestLength];
     SHA384Final(sha384_digest, sha384_ctx);
-    PrintDigest(mode == kAll ? "SHA384" : NULL, sha384_digest,
-                kSHA384DigestLength, mode != kAll ? filename : NULL);
+    PrintDigest(NULL, sha384_digest, kSHA384DigestLength, filename);
   }
-  if (mode == kAll) {
-    printf("\n");
+  if (binary_digest) {
+    WriteString(filename);
+    WriteOutput("", 1);
+  } else if (mode == kAll) {
+    WriteString("\n");
   }
 
 cleanup:
   if (file != stdin) {
     fclose(file);
   }
+  if (pipeline == NULL) {
+    free(multi_ctx);
+  }
   free(sha256_ctx);
   free(sha224_ctx);
   free(sha512_ctx);
   free(sha384_ctx);
+  if (flush_per_file) {
+    FlushOutput();
+  }
 }
 
 int main(int argc, char *argv[]) {
@@ -164,11 +410,40 @@ int main(int argc, char *argv[]) {
     mode = kAll;
   }
 
-  if (argc > 1) {
-    for (int i = 1; i < argc; ++i) {
+  // Only these exact arguments are options; anything else, including other
+  // names starting with '-', is treated as a file name as before.
+  int first_file = 1;
+  for (; first_file < argc; ++first_file) {
+    const char *arg = argv[first_file];
+    if (strcmp(arg, "-z") == 0 || strcmp(arg, "--binary-digest") == 0) {
+      binary_digest = true;
+    } else if (strcmp(arg, "--") == 0) {
+      ++first_file;
+      break;
+    } else {
+      break;
+    }
+  }
+
+  // Output is accumulated in our own buffer and written in large chunks, so
+  // stdio buffering would only add another copy.
+  setvbuf(stdout, NULL, _IONBF, 0);
+  flush_per_file = isatty(STDOUT_FILENO);
+
+  if (mode == kAll) {
+    StartPipeline();
+  }
+
+  if (first_file < argc) {
+    for (int i = first_file; i < argc; ++i) {
       ProcessFile(argv[i]);
     }
   } else {
     ProcessFile("-");
   }
+  FlushOutput();
+
+  if (pipeline != NULL) {
+    StopPipeline(kHasherCount);
+  }
 }
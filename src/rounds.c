@@ -192,3 +192,39 @@ void SHA512Compress(uint64_t state[], const uint8_t block[]) {
     state[i] += input_state[i];
   }
 }
+
+void SHA256Compress2(uint32_t state0[], uint32_t state1[],
+                     const uint8_t block[]) {
+  uint32_t working0[kSHA256StateSize / 32];
+  uint32_t working1[kSHA256StateSize / 32];
+  memcpy(working0, state0, sizeof(working0));
+  memcpy(working1, state1, sizeof(working1));
+  uint32_t words[kSHA256Rounds];
+  SHA256MessageSchedule(words, block);
+  for (size_t i = 0; i < kSHA256Rounds; ++i) {
+    SHA256Round(working0, kSHA256RoundConstants[i], words[i]);
+    SHA256Round(working1, kSHA256RoundConstants[i], words[i]);
+  }
+  for (size_t i = 0; i < kSHA256StateSize / 32; ++i) {
+    state0[i] += working0[i];
+    state1[i] += working1[i];
+  }
+}
+
+void SHA512Compress2(uint64_t state0[], uint64_t state1[],
+                     const uint8_t block[]) {
+  uint64_t working0[kSHA512StateSize / 64];
+  uint64_t working1[kSHA512StateSize / 64];
+  memcpy(working0, state0, sizeof(working0));
+  memcpy(working1, state1, sizeof(working1));
+  uint64_t words[kSHA512Rounds];
+  SHA512MessageSchedule(words, block);
+  for (size_t i = 0; i < kSHA512Rounds; ++i) {
+    SHA512Round(working0, kSHA512RoundConstants[i], words[i]);
+    SHA512Round(working1, kSHA512RoundConstants[i], words[i]);
+  }
+  for (size_t i = 0; i < kSHA512StateSize / 64; ++i) {
+    state0[i] += working0[i];
+    state1[i] += working1[i];
+  }
+}
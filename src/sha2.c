@@ -204,3 +204,119 @@ void SHA384Final(uint8_t digest[], const struct SHA384Context *ctx) {
     digest[8 * i + 7] = state[i] & 0xff;
   }
 }
+
+void SHA256MultiInit(struct SHA256MultiContext *ctx) {
+  memcpy(ctx->sha256_state, kSHA256IV, sizeof(kSHA256IV));
+  memcpy(ctx->sha224_state, kSHA224IV, sizeof(kSHA224IV));
+  ctx->length = 0;
+}
+
+void SHA512MultiInit(struct SHA512MultiContext *ctx) {
+  memcpy(ctx->sha512_state, kSHA512IV, sizeof(kSHA512IV));
+  memcpy(ctx->sha384_state, kSHA384IV, sizeof(kSHA384IV));
+  ctx->length = 0;
+}
+
+void SHA2MultiInit(struct SHA2MultiContext *ctx) {
+  SHA256MultiInit(&ctx->sha256);
+  SHA512MultiInit(&ctx->sha512);
+}
+
+void SHA256MultiUpdate(struct SHA256MultiContext *ctx, const void *data,
+                       size_t len) {
+  const uint8_t *bytes = data;
+  size_t buffered = ctx->length % (kSHA256BlockSize / 8);
+  ctx->length += len;
+  if (buffered > 0) {
+    size_t fill = (kSHA256BlockSize / 8) - buffered;
+    if (fill > len) {
+      fill = len;
+    }
+    memcpy(ctx->block + buffered, bytes, fill);
+    bytes += fill;
+    len -= fill;
+    if (buffered + fill < kSHA256BlockSize / 8) {
+      return;
+    }
+    SHA256Compress2(ctx->sha256_state, ctx->sha224_state, ctx->block);
+  }
+  // Whole blocks are compressed straight from the input.
+  for (; len >= kSHA256BlockSize / 8; len -= kSHA256BlockSize / 8) {
+    SHA256Compress2(ctx->sha256_state, ctx->sha224_state, bytes);
+    bytes += kSHA256BlockSize / 8;
+  }
+  memcpy(ctx->block, bytes, len);
+}
+
+void SHA512MultiUpdate(struct SHA512MultiContext *ctx, const void *data,
+                       size_t len) {
+  const uint8_t *bytes = data;
+  size_t buffered = ctx->length % (kSHA512BlockSize / 8);
+  ctx->length += len;
+  if (buffered > 0) {
+    size_t fill = (kSHA512BlockSize / 8) - buffered;
+    if (fill > len) {
+      fill = len;
+    }
+    memcpy(ctx->block + buffered, bytes, fill);
+    bytes += fill;
+    len -= fill;
+    if (buffered + fill < kSHA512BlockSize / 8) {
+      return;
+    }
+    SHA512Compress2(ctx->sha512_state, ctx->sha384_state, ctx->block);
+  }
+  // Whole blocks are compressed straight from the input.
+  for (; len >= kSHA512BlockSize / 8; len -= kSHA512BlockSize / 8) {
+    SHA512Compress2(ctx->sha512_state, ctx->sha384_state, bytes);
+    bytes += kSHA512BlockSize / 8;
+  }
+  memcpy(ctx->block, bytes, len);
+}
+
+void SHA2MultiUpdate(struct SHA2MultiContext *ctx, const void *data,
+                     size_t len) {
+  SHA256MultiUpdate(&ctx->sha256, data, len);
+  SHA512MultiUpdate(&ctx->sha512, data, len);
+}
+
+void SHA256MultiFinal(uint8_t sha256_digest[], uint8_t sha224_digest[],
+                      const struct SHA256MultiContext *ctx) {
+  // The buffered tail is common to both digests; only the states differ.
+  size_t buffered = ctx->length % (kSHA256BlockSize / 8);
+  struct SHA256Context sha256_ctx;
+  memcpy(sha256_ctx.state, ctx->sha256_state, sizeof(sha256_ctx.state));
+  memcpy(sha256_ctx.block, ctx->block, buffered);
+  sha256_ctx.length = ctx->length;
+  SHA256Final(sha256_digest, &sha256_ctx);
+
+  struct SHA224Context sha224_ctx;
+  memcpy(sha224_ctx.state, ctx->sha224_state, sizeof(sha224_ctx.state));
+  memcpy(sha224_ctx.block, ctx->block, buffered);
+  sha224_ctx.length = ctx->length;
+  SHA224Final(sha224_digest, &sha224_ctx);
+}
+
+void SHA512MultiFinal(uint8_t sha512_digest[], uint8_t sha384_digest[],
+                      const struct SHA512MultiContext *ctx) {
+  // The buffered tail is common to both digests; only the states differ.
+  size_t buffered = ctx->length % (kSHA512BlockSize / 8);
+  struct SHA512Context sha512_ctx;
+  memcpy(sha512_ctx.state, ctx->sha512_state, sizeof(sha512_ctx.state));
+  memcpy(sha512_ctx.block, ctx->block, buffered);
+  sha512_ctx.length = ctx->length;
+  SHA512Final(sha512_digest, &sha512_ctx);
+
+  struct SHA384Context sha384_ctx;
+  memcpy(sha384_ctx.state, ctx->sha384_state, sizeof(sha384_ctx.state));
+  memcpy(sha384_ctx.block, ctx->block, buffered);
+  sha384_ctx.length = ctx->length;
+  SHA384Final(sha384_digest, &sha384_ctx);
+}
+
+void SHA2MultiFinal(uint8_t sha256_digest[], uint8_t sha224_digest[],
+                    uint8_t sha512_digest[], uint8_t sha384_digest[],
+                    const struct SHA2MultiContext *ctx) {
+  SHA256MultiFinal(sha256_digest, sha224_digest, &ctx->sha256);
+  SHA512MultiFinal(sha512_digest, sha384_digest, &ctx->sha512);
+}
@@ -52,6 +52,46 @@ void SHA384Init(struct SHA384Context *ctx);
 void SHA384Update(struct SHA384Context *ctx, const void *data, size_t len);
 void SHA384Final(uint8_t digest[], const struct SHA384Context *ctx);
 
+// Computes SHA-256 and SHA-224 together, sharing one message schedule per
+// block.
+struct SHA256MultiContext {
+  uint32_t sha256_state[kSHA256StateSize / 32];
+  uint32_t sha224_state[kSHA256StateSize / 32];
+  uint8_t block[kSHA256BlockSize / 8];
+  size_t length;
+};
+void SHA256MultiInit(struct SHA256MultiContext *ctx);
+void SHA256MultiUpdate(struct SHA256MultiContext *ctx, const void *data,
+                       size_t len);
+void SHA256MultiFinal(uint8_t sha256_digest[], uint8_t sha224_digest[],
+                      const struct SHA256MultiContext *ctx);
+
+// Computes SHA-512 and SHA-384 together, sharing one message schedule per
+// block.
+struct SHA512MultiContext {
+  uint64_t sha512_state[kSHA512StateSize / 64];
+  uint64_t sha384_state[kSHA512StateSize / 64];
+  uint8_t block[kSHA512BlockSize / 8];
+  size_t length;
+};
+void SHA512MultiInit(struct SHA512MultiContext *ctx);
+void SHA512MultiUpdate(struct SHA512MultiContext *ctx, const void *data,
+                       size_t len);
+void SHA512MultiFinal(uint8_t sha512_digest[], uint8_t sha384_digest[],
+                      const struct SHA512MultiContext *ctx);
+
+// Computes all four digests in one pass.
+struct SHA2MultiContext {
+  struct SHA256MultiContext sha256;
+  struct SHA512MultiContext sha512;
+};
+void SHA2MultiInit(struct SHA2MultiContext *ctx);
+void SHA2MultiUpdate(struct SHA2MultiContext *ctx, const void *data,
+                     size_t len);
+void SHA2MultiFinal(uint8_t sha256_digest[], uint8_t sha224_digest[],
+                    uint8_t sha512_digest[], uint8_t sha384_digest[],
+                    const struct SHA2MultiContext *ctx);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif